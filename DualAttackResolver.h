@@ -0,0 +1,185 @@
+#pragma once
+
+// Game independent part of the release handling, so it can be replayed by the benchmark in bench/.
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+const uint64_t DUAL_ATTACK_TIME_DIFF = 130;
+const uint64_t DUAL_WIELD_PARRY_DELAY = 100;
+
+enum class ReleaseResolution { Ignore, Single, Dual, Pending };
+
+inline bool IsDualRelease(bool isDualWielding, bool isDualHeld, uint64_t timeDiff) {
+    return isDualWielding && isDualHeld && timeDiff < DUAL_ATTACK_TIME_DIFF;
+}
+
+// While the other hand is still held the release can't be final yet, a dual wielding player gets a pending
+// single attack, which is either fired when the window closes or upgraded to dual by the partner release.
+inline ReleaseResolution ResolveRelease(bool isOtherHandHeld, bool isDualWielding, bool isDualHeld,
+                                        uint64_t timeDiff) {
+    if (isOtherHandHeld) {
+        return isDualWielding ? ReleaseResolution::Pending : ReleaseResolution::Ignore;
+    }
+
+    return IsDualRelease(isDualWielding, isDualHeld, timeDiff) ? ReleaseResolution::Dual : ReleaseResolution::Single;
+}
+
+// Dual Wield Parry needs the left release to settle before the dual attack, time since it was sent counts.
+inline uint64_t DualWieldParryDelay(uint64_t sinceLeftRelease) {
+    if (sinceLeftRelease >= DUAL_WIELD_PARRY_DELAY) {
+        return 0;
+    }
+
+    return DUAL_WIELD_PARRY_DELAY - sinceLeftRelease;
+}
+
+// Holds one pending attack. Schedule, Cancel and Flush have to be called from the game thread,
+// the timer thread only posts a task back to it, which fires the attack unless it was replaced or cancelled.
+class PendingAttackSlot {
+public:
+    typedef std::function<void(std::function<void()>)> FnPostTask;
+
+    bool IsPending() const { return attack != nullptr; }
+
+    bool Cancel() {
+        if (!attack) {
+            return false;
+        }
+
+        attack = nullptr;
+        generation++;
+
+        return true;
+    }
+
+    void Flush() {
+        if (!attack) {
+            return;
+        }
+
+        auto pendingAttack = std::move(attack);
+        attack = nullptr;
+        generation++;
+
+        pendingAttack();
+    }
+
+    void Schedule(std::function<void()> pendingAttack, uint64_t delay, FnPostTask postTask) {
+        Flush();
+
+        attack = std::move(pendingAttack);
+        uint64_t scheduledGeneration = ++generation;
+
+        std::thread thread([this, scheduledGeneration, delay, postTask]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+
+            postTask([this, scheduledGeneration]() {
+                if (scheduledGeneration != generation) {
+                    return;
+                }
+
+                Flush();
+            });
+        });
+        thread.detach();
+    }
+
+private:
+    std::function<void()> attack;
+    uint64_t generation = 0;
+};
+
+// Outcome of a single button release, Upgrade is a dual attack that replaced a pending single attack.
+enum class ReleaseOutcome { Ignored, Single, Dual, Upgrade, Pending, LeftReleased, Parry };
+
+struct ReleaseEvent {
+    bool isLeft;
+    bool isOtherHandHeld;
+    bool isDualWielding;
+    bool isDualHeld;
+    bool isDualWieldParry;
+    bool isBlocking;
+    uint64_t timeDiff;
+    uint64_t time;
+};
+
+struct ReleaseActions {
+    // Called with true when the attack comes from the pending slot, then only the released hand counts
+    std::function<void(bool isPending)> performSingle;
+    std::function<void(uint64_t delay)> performDual;
+    std::function<void()> sendLeftRelease;
+};
+
+// Resolves button releases into single, pending single or dual attacks. Owns the pending slot and
+// the early Dual Wield Parry left release, so it has to be used from the game thread only.
+class DualAttackResolver {
+public:
+    explicit DualAttackResolver(PendingAttackSlot::FnPostTask postTask) : postTask(std::move(postTask)) {}
+
+    // New left press starts a new block, the early Dual Wield Parry release no longer applies
+    void OnLeftDown() { isLeftReleaseSent = false; }
+
+    ReleaseOutcome Release(const ReleaseEvent& event, const ReleaseActions& actions) {
+        auto resolution = ResolveRelease(event.isOtherHandHeld, event.isDualWielding, event.isDualHeld, event.timeDiff);
+
+        if (resolution == ReleaseResolution::Ignore) {
+            return ReleaseOutcome::Ignored;
+        }
+
+        if (resolution == ReleaseResolution::Single) {
+            actions.performSingle(false);
+            isLeftReleaseSent = false;
+
+            return ReleaseOutcome::Single;
+        }
+
+        if (resolution == ReleaseResolution::Dual) {
+            // Partner release landed in the window, the pending single attack is replaced by dual
+            auto outcome = pendingAttack.Cancel() ? ReleaseOutcome::Upgrade : ReleaseOutcome::Dual;
+            uint64_t delay = 0;
+
+            if (event.isDualWieldParry) {
+                if (!isLeftReleaseSent) {
+                    actions.sendLeftRelease();
+                }
+
+                delay = DualWieldParryDelay(isLeftReleaseSent ? event.time - leftReleaseSentTime : 0);
+            }
+
+            actions.performDual(delay);
+            isLeftReleaseSent = false;
+
+            return outcome;
+        }
+
+        if (event.isDualWieldParry) {
+            // Release the block right away, a following dual attack then waits only for the rest of the delay
+            if (event.isLeft) {
+                actions.sendLeftRelease();
+                isLeftReleaseSent = true;
+                leftReleaseSentTime = event.time;
+
+                return ReleaseOutcome::LeftReleased;
+            }
+
+            // Right release while blocking with left keeps the parry behavior, no attack
+            if (event.isBlocking) {
+                return ReleaseOutcome::Parry;
+            }
+        }
+
+        auto performSingle = actions.performSingle;
+        pendingAttack.Schedule([performSingle]() { performSingle(true); }, DUAL_ATTACK_TIME_DIFF, postTask);
+
+        return ReleaseOutcome::Pending;
+    }
+
+private:
+    PendingAttackSlot pendingAttack;
+    PendingAttackSlot::FnPostTask postTask;
+    bool isLeftReleaseSent = false;
+    uint64_t leftReleaseSentTime = 0;
+};
@@ -0,0 +1,263 @@
+// Replays scripted release timings through the plugin's DualAttackResolver on a simulated 60 fps game thread and
+// reports latency percentiles for single and dual outcomes. Single attacks are measured from the first release to
+// the first single attack of either hand, dual attacks from the partner release to the dual attack.
+// Legacy rows replay the release handling as it was before the resolver: the first released hand waits for its
+// partner and is dropped when the partner is late, and Dual Wield Parry always sleeps the full delay.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "DualAttackResolver.h"
+
+typedef std::chrono::steady_clock Clock;
+
+const auto FRAME_TIME = std::chrono::microseconds(16667);
+const double SCENARIO_TIMEOUT = 400.0;
+const double SCENARIO_SETTLE_TIME = DUAL_ATTACK_TIME_DIFF + 50.0;
+const int DEFAULT_ITERATIONS = 50;
+
+enum class Outcome { Single, Dual };
+
+struct Scenario {
+    const char* name;
+    bool isLegacy;
+    bool isPartnerPressed;
+    bool isDualWieldParry;
+    double minGap;
+    double maxGap;
+    Outcome outcome;
+};
+
+struct Emission {
+    Outcome outcome;
+    bool isLeft;
+    double time;
+};
+
+struct HandState {
+    bool isHeld = false;
+    bool isReleased = false;
+    uint64_t lastTime = 0;
+};
+
+std::mutex taskMutex;
+std::vector<std::function<void()>> taskQueue;
+
+Clock::time_point scenarioStart;
+
+void AddTask(std::function<void()> task);
+
+// Everything below is only touched from the game thread, like in the plugin
+DualAttackResolver dualAttackResolver(AddTask);
+std::vector<Emission> emissions;
+HandState leftHand;
+HandState rightHand;
+
+double NowMs() {
+    return std::chrono::duration<double, std::milli>(Clock::now() - scenarioStart).count();
+}
+
+void AddTask(std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(taskMutex);
+    taskQueue.push_back(std::move(task));
+}
+
+void RunTasks() {
+    std::vector<std::function<void()>> tasks;
+
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        tasks.swap(taskQueue);
+    }
+
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+// Same as the plugin, the action itself runs as a game task, optionally after a delay on a helper thread
+void PerformAction(Outcome outcome, bool isLeft, uint64_t delay) {
+    auto action = [outcome, isLeft]() { emissions.push_back({outcome, isLeft, NowMs()}); };
+
+    if (delay == 0) {
+        AddTask(action);
+        return;
+    }
+
+    std::thread thread([action, delay]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+        AddTask(action);
+    });
+    thread.detach();
+}
+
+// Baseline release handling: nothing happens while the other hand is held, dual sends the left release right away
+void LegacyRelease(const Scenario& scenario, bool isLeft, bool isOtherHandHeld, uint64_t timeDiff) {
+    auto resolution = ResolveRelease(isOtherHandHeld, true, scenario.isPartnerPressed, timeDiff);
+
+    if (resolution == ReleaseResolution::Single) {
+        PerformAction(Outcome::Single, isLeft, 0);
+    }
+
+    if (resolution == ReleaseResolution::Dual) {
+        PerformAction(Outcome::Dual, isLeft, scenario.isDualWieldParry ? DualWieldParryDelay(0) : 0);
+    }
+}
+
+void OnRelease(const Scenario& scenario, bool isLeft) {
+    auto& hand = isLeft ? leftHand : rightHand;
+    auto& otherHand = isLeft ? rightHand : leftHand;
+
+    bool isOtherHandHeld = otherHand.isHeld;
+    hand.isHeld = false;
+    hand.isReleased = true;
+    hand.lastTime = (uint64_t)NowMs();
+
+    uint64_t timeDiff = leftHand.lastTime > rightHand.lastTime ? leftHand.lastTime - rightHand.lastTime
+                                                               : rightHand.lastTime - leftHand.lastTime;
+
+    if (scenario.isLegacy) {
+        LegacyRelease(scenario, isLeft, isOtherHandHeld, timeDiff);
+        return;
+    }
+
+    ReleaseEvent event;
+    event.isLeft = isLeft;
+    event.isOtherHandHeld = isOtherHandHeld;
+    event.isDualWielding = true;
+    event.isDualHeld = scenario.isPartnerPressed;
+    event.isDualWieldParry = scenario.isDualWieldParry;
+    event.isBlocking = false;
+    event.timeDiff = timeDiff;
+    event.time = hand.lastTime;
+
+    // Left release is a plain game action in the plugin, it is not part of the measured latency
+    ReleaseActions actions;
+    actions.performSingle = [isLeft](bool) { PerformAction(Outcome::Single, isLeft, 0); };
+    actions.performDual = [isLeft](uint64_t delay) { PerformAction(Outcome::Dual, isLeft, delay); };
+    actions.sendLeftRelease = []() {};
+
+    dualAttackResolver.Release(event, actions);
+}
+
+// Returns the latency in ms, or a negative value when the expected action never happened
+double RunScenario(const Scenario& scenario, std::mt19937& random) {
+    std::uniform_real_distribution<double> phase(0.0, 16.667);
+    std::uniform_real_distribution<double> gap(scenario.minGap, scenario.maxGap);
+
+    // Left goes up first, it is the hand the Dual Wield Parry early release applies to
+    double leftRelease = phase(random);
+    double rightRelease = leftRelease + gap(random);
+    double lastRelease = scenario.isPartnerPressed ? rightRelease : leftRelease;
+
+    dualAttackResolver.OnLeftDown();
+    emissions.clear();
+    leftHand = HandState{true, false, 0};
+    rightHand = HandState{scenario.isPartnerPressed, false, 0};
+
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        taskQueue.clear();
+    }
+
+    scenarioStart = Clock::now();
+
+    double latency = -1.0;
+
+    // Keeps running after the measured action until pending and delayed actions are done, so none leak into the
+    // next scenario
+    for (int frame = 1;; frame++) {
+        if (!leftHand.isReleased && NowMs() >= leftRelease) {
+            OnRelease(scenario, true);
+        }
+
+        if (scenario.isPartnerPressed && !rightHand.isReleased && NowMs() >= rightRelease) {
+            OnRelease(scenario, false);
+        }
+
+        RunTasks();
+
+        for (auto& emission : emissions) {
+            if (latency >= 0.0 || emission.outcome != scenario.outcome) {
+                continue;
+            }
+
+            latency = emission.time - (scenario.outcome == Outcome::Single ? leftRelease : rightRelease);
+        }
+
+        if (NowMs() > lastRelease + (latency >= 0.0 ? SCENARIO_SETTLE_TIME : SCENARIO_TIMEOUT)) {
+            return latency;
+        }
+
+        std::this_thread::sleep_until(scenarioStart + frame * FRAME_TIME);
+    }
+}
+
+double Percentile(const std::vector<double>& sorted, double percentile) {
+    size_t rank = (size_t)(percentile / 100.0 * sorted.size() + 0.999999);
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : DEFAULT_ITERATIONS;
+
+    // Late partner releases start past the window plus one frame, since release times are frame aligned
+    const double lateGap = DUAL_ATTACK_TIME_DIFF + 20.0;
+    const double inWindowGap = DUAL_ATTACK_TIME_DIFF - 30.0;
+
+    const Scenario scenarios[] = {
+        {"single, one hand pressed", true, false, false, 0.0, 0.0, Outcome::Single},
+        {"single, one hand pressed", false, false, false, 0.0, 0.0, Outcome::Single},
+        {"single, two hands pressed, partner late", true, true, false, lateGap, 400.0, Outcome::Single},
+        {"single, two hands pressed, partner late", false, true, false, lateGap, 400.0, Outcome::Single},
+        {"dual, partner in window", true, true, false, 0.0, inWindowGap, Outcome::Dual},
+        {"dual, partner in window", false, true, false, 0.0, inWindowGap, Outcome::Dual},
+        {"dual, Dual Wield Parry, left first", true, true, true, 0.0, inWindowGap, Outcome::Dual},
+        {"dual, Dual Wield Parry, left first", false, true, true, 0.0, inWindowGap, Outcome::Dual},
+    };
+
+    std::mt19937 random(42);
+
+    std::printf("release to action latency in ms, %d runs per scenario, %d ms dual window, 60 fps\n\n", iterations,
+                (int)DUAL_ATTACK_TIME_DIFF);
+    std::printf("%-42s %-7s %7s %7s %7s %7s %8s\n", "scenario", "mode", "p50", "p95", "p99", "max", "dropped");
+
+    for (auto& scenario : scenarios) {
+        std::vector<double> latencies;
+        int dropped = 0;
+
+        for (int i = 0; i < iterations; i++) {
+            double latency = RunScenario(scenario, random);
+
+            if (latency < 0.0) {
+                dropped++;
+            } else {
+                latencies.push_back(latency);
+            }
+        }
+
+        const char* mode = scenario.isLegacy ? "legacy" : "pending";
+
+        if (latencies.empty()) {
+            std::printf("%-42s %-7s %7s %7s %7s %7s %4d/%-3d\n", scenario.name, mode, "-", "-", "-", "-", dropped,
+                        iterations);
+            continue;
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        std::printf("%-42s %-7s %7.1f %7.1f %7.1f %7.1f %4d/%-3d\n", scenario.name, mode, Percentile(latencies, 50),
+                    Percentile(latencies, 95), Percentile(latencies, 99), latencies.back(), dropped, iterations);
+    }
+
+    // Let detached timer threads finish before the globals they post into go away
+    std::this_thread::sleep_for(std::chrono::milliseconds(DUAL_ATTACK_TIME_DIFF + DUAL_WIELD_PARRY_DELAY));
+
+    return 0;
+}
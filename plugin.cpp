@@ -1,6 +1,8 @@
 #include <SimpleIni.h>
 #include <spdlog/sinks/basic_file_sink.h>
 
+#include "DualAttackResolver.h"
+
 namespace logger = SKSE::log;
 using namespace RE;
 using namespace RE::BSScript;
@@ -10,11 +12,13 @@ using namespace SKSE::stl;
 const bool IS_DEBUG = false;
 
 const int ACTION_MAX_RETRY = 4;
-const uint64_t DUAL_ATTACK_TIME_DIFF = 130;
 const int POWER_ATTACK_MIN_HOLD_TIME = 440;
 const int VIBRATION_STRENGTH = 25;
 const int DEFAULT_LEFT_BUTTON = 280;
 const int DEFAULT_RIGHT_BUTTON = 281;
+const int ANALOG_TRIGGER_MIN_DEPTH = 50;
+const int ANALOG_TRIGGER_FULL_DEPTH = 95;
+const int ANALOG_TRIGGER_MIN_HOLD_TIME = 150;
 
 bool isEnabled = true;
 bool isSoundEnabled = true;
@@ -24,6 +28,10 @@ float vibrationStrength = 0.25f;
 uint64_t leftButton = DEFAULT_LEFT_BUTTON;
 uint64_t rightButton = DEFAULT_RIGHT_BUTTON;
 bool isMouseReversed = false;
+bool isAnalogTriggerEnabled = false;
+float analogTriggerMinDepth = 0.5f;
+float analogTriggerFullDepth = 0.95f;
+float analogTriggerMinHoldMs = 0.15f;
 
 bool dualWieldParryCompatibility = false;
 
@@ -44,6 +52,9 @@ BGSAction* actionRightRelease;
 float leftHoldTime = 0.0f;
 float rightHoldTime = 0.0f;
 
+float leftTriggerDepth = 0.0f;
+float rightTriggerDepth = 0.0f;
+
 uint64_t leftLastTime = 0;
 uint64_t rightLastTime = 0;
 
@@ -115,6 +126,14 @@ void LoadSettings() {
     rightButton =
         LimitGamepadButton(ini.GetLongValue("Buttons", "OverrideRightButton", DEFAULT_RIGHT_BUTTON), DEFAULT_RIGHT_BUTTON);
     isMouseReversed = ini.GetBoolValue("Buttons", "ReverseMouseButtons", false);
+    isAnalogTriggerEnabled = ini.GetBoolValue("Buttons", "AnalogTriggers", false);
+    auto fullDepth = Limit(1, ini.GetLongValue("Buttons", "AnalogTriggerFullDepth", ANALOG_TRIGGER_FULL_DEPTH), 100);
+    auto minDepth =
+        Limit(0, ini.GetLongValue("Buttons", "AnalogTriggerMinDepth", ANALOG_TRIGGER_MIN_DEPTH), fullDepth - 1);
+    analogTriggerFullDepth = fullDepth / 100.0f;
+    analogTriggerMinDepth = minDepth / 100.0f;
+    auto minHoldTime = ini.GetLongValue("Buttons", "AnalogTriggerMinHoldMs", ANALOG_TRIGGER_MIN_HOLD_TIME);
+    analogTriggerMinHoldMs = Limit(0, minHoldTime, (long)(minPowerAttackHoldMs * 1000.0f)) / 1000.0f;
 
     dualWieldParryCompatibility = ini.GetBoolValue("Compatibility", "BorgutDualWieldParry", false);
 
@@ -126,6 +145,10 @@ void LoadSettings() {
     ini.SetLongValue("Buttons", "OverrideLeftButton", (long)leftButton);
     ini.SetLongValue("Buttons", "OverrideRightButton", (long)rightButton);
     ini.SetBoolValue("Buttons", "ReverseMouseButtons", isMouseReversed);
+    ini.SetBoolValue("Buttons", "AnalogTriggers", isAnalogTriggerEnabled);
+    ini.SetLongValue("Buttons", "AnalogTriggerMinDepth", (long)(analogTriggerMinDepth * 100.0f + 0.5f));
+    ini.SetLongValue("Buttons", "AnalogTriggerFullDepth", (long)(analogTriggerFullDepth * 100.0f + 0.5f));
+    ini.SetLongValue("Buttons", "AnalogTriggerMinHoldMs", (long)(analogTriggerMinHoldMs * 1000.0f + 0.5f));
     ini.SetBoolValue("Compatibility", "BorgutDualWieldParry", dualWieldParryCompatibility);
 
     (void)ini.SaveFile(path);
@@ -198,24 +221,34 @@ void PerformAction(BGSAction* action, Actor* actor, int index) {
     });
 }
 
-void PerformActionWithDelay(BGSAction* action, Actor* actor, int index) {
-    std::thread thread([action, actor, index]() {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+void PerformActionWithDelay(BGSAction* action, Actor* actor, int index, uint64_t delay) {
+    if (delay == 0) {
+        PerformAction(action, actor, index);
+        return;
+    }
+
+    std::thread thread([action, actor, index, delay]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay));
         PerformAction(action, actor, index);
     });
     thread.detach();
 }
 
-void PerformAction(BGSAction* action, Actor* actor, bool isPowerAttack) {
+void PerformAction(BGSAction* action, Actor* actor, bool isPowerAttack, uint64_t delay = 0) {
     int index = isPowerAttack ? 0 : ACTION_MAX_RETRY;
 
-    if (dualWieldParryCompatibility && IsActionDualAttack(action)) {
-        PerformActionWithDelay(action, actor, index);
+    PerformActionWithDelay(action, actor, index, delay);
+}
+
+DualAttackResolver dualAttackResolver([](std::function<void()> task) {
+    if (tasks == NULL) {
+        logger::info("Tasks not initialized.");
+
         return;
     }
 
-    PerformAction(action, actor, index);
-}
+    tasks->AddTask(std::move(task));
+});
 
 void PlayDebugSound(BGSSoundDescriptorForm* sound, PlayerCharacter* player) {
     if (!isSoundEnabled) {
@@ -344,12 +377,25 @@ bool IsDualWielding(PlayerCharacter* player) {
     return IsWeaponValid(weaponLeft, true) && IsWeaponValid(weaponRight, false);
 }
 
-bool IsPowerAttackAlt(PlayerCharacter* player, float maxDuration, bool isLeftHandBusy, bool isRightHandBusy, bool isBlocking) {
+// Below the min depth the trigger behaves like a button, past it the hold threshold shrinks linearly
+// down to the analog min hold time, which still applies at full depth so quick taps stay light attacks.
+bool IsHoldPowerAttack(float holdTime, float triggerDepth) {
+    if (!isAnalogTriggerEnabled || triggerDepth < analogTriggerMinDepth) {
+        return holdTime > minPowerAttackHoldMs;
+    }
+
+    float scale = (analogTriggerFullDepth - triggerDepth) / (analogTriggerFullDepth - analogTriggerMinDepth);
+
+    return holdTime > analogTriggerMinHoldMs + (minPowerAttackHoldMs - analogTriggerMinHoldMs) * Max(scale, 0.0f);
+}
+
+bool IsPowerAttackAlt(PlayerCharacter* player, bool isHoldPowerAttack, bool isLeftHandBusy, bool isRightHandBusy,
+                      bool isBlocking) {
     if (GetPlayerStamina(player) <= 1.0f) {
         return false;
     }
 
-    auto isPowerAttack = maxDuration > minPowerAttackHoldMs;
+    auto isPowerAttack = isHoldPowerAttack;
     bool isDualWielding = IsDualWielding(player);
 
     if ((!dualWieldParryCompatibility || !isDualWielding) && (isLeftHandBusy || isRightHandBusy) && !isBlocking) {
@@ -374,7 +420,7 @@ bool IsPowerAttack(PlayerCharacter* player, float maxDuration, bool isOtherHandB
 }
 
 BGSAction* GetAttackAction(bool isLeft, uint64_t timeDiff, bool isDualWielding, bool isDualHeld, bool isPowerAttack) {
-    if (isDualWielding && isDualHeld && timeDiff < DUAL_ATTACK_TIME_DIFF) {
+    if (IsDualRelease(isDualWielding, isDualHeld, timeDiff)) {
         return isPowerAttack ? actionDualPowerAttack : actionDualAttack;
     }
 
@@ -395,6 +441,21 @@ bool IsEventLeft(ButtonEvent* a_event) {
     return false;
 }
 
+float GetTriggerDepth(ButtonEvent* a_event) {
+    if (!isAnalogTriggerEnabled || a_event->device.get() != INPUT_DEVICE::kGamepad) {
+        return 0.0f;
+    }
+
+    auto gamepadKey = static_cast<RE::BSWin32GamepadDevice::Key>(a_event->GetIDCode());
+
+    if (gamepadKey != RE::BSWin32GamepadDevice::Key::kLeftTrigger &&
+        gamepadKey != RE::BSWin32GamepadDevice::Key::kRightTrigger) {
+        return 0.0f;
+    }
+
+    return Min(Max(a_event->Value(), 0.0f), 1.0f);
+}
+
 bool IsButtonEventValid(ButtonEvent* a_event) {
     if (!isEnabled) {
         return false;
@@ -505,6 +566,9 @@ private:
         auto tempLeftHoldTime = leftHoldTime;
         auto tempRightHoldTime = rightHoldTime;
 
+        auto tempLeftTriggerDepth = leftTriggerDepth;
+        auto tempRightTriggerDepth = rightTriggerDepth;
+
         auto tempIsLeftDualHeld = isLeftDualHeld;
         auto tempIsRightDualHeld = isRightDualHeld;
 
@@ -515,11 +579,13 @@ private:
 
         if (isLeft) {
             leftHoldTime = 0.0f;
+            leftTriggerDepth = 0.0f;
             leftLastTime = TimeMillisec();
             isRightDualHeld = false;
             shouldAttack = tempRightHoldTime == 0.0f;
         } else {
             rightHoldTime = 0.0f;
+            rightTriggerDepth = 0.0f;
             rightLastTime = TimeMillisec();
             isLeftDualHeld = false;
             shouldAttack = tempLeftHoldTime == 0.0f;
@@ -527,65 +593,107 @@ private:
 
         timeDiff = AbsDiff(leftLastTime, rightLastTime);
 
+        auto isDualHeld = isLeft ? tempIsRightDualHeld : tempIsLeftDualHeld;
+
         bool isBlocking = false;
         playerCharacter->GetGraphVariableBool("IsBlocking", isBlocking);
 
-        if (shouldAttack || (timeDiff == 0 && isLeft)) {
-            if (timeDiff == 0) {
-                logger::info("Nice reflex!");
-            }
+        ReleaseEvent event;
+        event.isLeft = isLeft;
+        event.isOtherHandHeld = !shouldAttack && !(timeDiff == 0 && isLeft);
+        event.isDualWielding = isDualWielding;
+        event.isDualHeld = isDualHeld;
+        event.isDualWieldParry = dualWieldParryCompatibility;
+        event.isBlocking = isBlocking;
+        event.timeDiff = timeDiff;
+        event.time = TimeMillisec();
+
+        ReleaseActions actions;
+        actions.performSingle = [playerCharacter, isLeft, timeDiff, isDualWielding, tempLeftHoldTime, tempRightHoldTime,
+                                 tempLeftTriggerDepth, tempRightTriggerDepth](bool isPending) {
+            auto isLeftPowerAttack = IsHoldPowerAttack(tempLeftHoldTime, tempLeftTriggerDepth);
+            auto isRightPowerAttack = IsHoldPowerAttack(tempRightHoldTime, tempRightTriggerDepth);
+
+            // Other hand was still held for a pending attack, its hold time belongs to its own release
+            auto isHoldPowerAttack = isPending ? (isLeft ? isLeftPowerAttack : isRightPowerAttack)
+                                               : isLeftPowerAttack || isRightPowerAttack;
+
+            PerformAttack(playerCharacter, isLeft, timeDiff, isDualWielding, false, isHoldPowerAttack, 0);
+        };
+        actions.performDual = [playerCharacter, isLeft, timeDiff, isDualWielding, isDualHeld, tempLeftHoldTime,
+                               tempRightHoldTime, tempLeftTriggerDepth, tempRightTriggerDepth](uint64_t delay) {
+            auto isHoldPowerAttack = IsHoldPowerAttack(tempLeftHoldTime, tempLeftTriggerDepth) ||
+                                     IsHoldPowerAttack(tempRightHoldTime, tempRightTriggerDepth);
+
+            PerformAttack(playerCharacter, isLeft, timeDiff, isDualWielding, isDualHeld, isHoldPowerAttack, delay);
+        };
+        actions.sendLeftRelease = [playerCharacter]() { PerformAction(actionLeftRelease, playerCharacter, false); };
+
+        auto outcome = dualAttackResolver.Release(event, actions);
+
+        if (timeDiff == 0 && (outcome == ReleaseOutcome::Single || outcome == ReleaseOutcome::Dual ||
+                              outcome == ReleaseOutcome::Upgrade)) {
+            logger::info("Nice reflex!");
+        }
 
-            SetIsAttackIndicated(isLeft, false);
+        if (IS_DEBUG && outcome == ReleaseOutcome::Upgrade) {
+            logger::info("Pending single attack upgraded to dual attack.");
+        }
 
-            auto isDualHeld = isLeft ? tempIsRightDualHeld : tempIsLeftDualHeld;
-            float maxHoldTime = Max(tempLeftHoldTime, tempRightHoldTime);
+        if (IS_DEBUG && outcome == ReleaseOutcome::Pending) {
+            logger::info("Single attack pending for partner release.");
+        }
+    }
 
-            auto isAttacking = IsPlayerAttacking(playerCharacter);
-            auto isPowerAttack =
-                IsPowerAttackAlt(playerCharacter, maxHoldTime, leftAltBehavior, rightAltBehavior, isBlocking);
+    static void PerformAttack(PlayerCharacter* playerCharacter, bool isLeft, uint64_t timeDiff, bool isDualWielding,
+                              bool isDualHeld, bool isHoldPowerAttack, uint64_t dualDelay) {
+        bool isBlocking = false;
+        playerCharacter->GetGraphVariableBool("IsBlocking", isBlocking);
 
-            auto attackAction = GetAttackAction(isLeft, timeDiff, isDualWielding, isDualHeld, false);
+        SetIsAttackIndicated(isLeft, false);
 
-            // Borgut Dual Wield Parry Compatibility
-            if (dualWieldParryCompatibility && isLeft && isDualWielding && !IsActionDualAttack(attackAction)) {
-                PerformAction(actionLeftRelease, playerCharacter, false);
+        auto isAttacking = IsPlayerAttacking(playerCharacter);
+        auto isPowerAttack =
+            IsPowerAttackAlt(playerCharacter, isHoldPowerAttack, leftAltBehavior, rightAltBehavior, isBlocking);
 
-                return;
-            }
+        auto attackAction = GetAttackAction(isLeft, timeDiff, isDualWielding, isDualHeld, false);
 
-            if (!isPowerAttack || (isPowerAttack && !isAttacking)) {
-                // Borgut Dual Wield Parry Compatibility
-                if (dualWieldParryCompatibility && IsActionDualAttack(attackAction)) {
-                    PerformAction(actionLeftRelease, playerCharacter, false);
-                }
+        // Borgut Dual Wield Parry Compatibility
+        if (dualWieldParryCompatibility && isLeft && isDualWielding && !IsActionDualAttack(attackAction)) {
+            PerformAction(actionLeftRelease, playerCharacter, false);
+
+            return;
+        }
 
-                PerformAction(attackAction, playerCharacter, false);
+        if (!isPowerAttack || (isPowerAttack && !isAttacking)) {
+            PerformAction(attackAction, playerCharacter, false, dualDelay);
 
-                if (!isLeft && !isPowerAttack && isBlocking) {
-                    PerformAction(actionRightRelease, playerCharacter, false);
-                }
+            if (!isLeft && !isPowerAttack && isBlocking) {
+                PerformAction(actionRightRelease, playerCharacter, false);
             }
+        }
 
-            if (isPowerAttack && !isAttacking && (!isBlocking || (dualWieldParryCompatibility && isDualWielding))) {
-                attackAction = GetAttackAction(isLeft, timeDiff, isDualWielding, isDualHeld, true);
+        if (isPowerAttack && !isAttacking && (!isBlocking || (dualWieldParryCompatibility && isDualWielding))) {
+            attackAction = GetAttackAction(isLeft, timeDiff, isDualWielding, isDualHeld, true);
 
-                PerformAction(attackAction, playerCharacter, true);
-            }
+            PerformAction(attackAction, playerCharacter, true, dualDelay);
+        }
 
-            if (!IsActionDualAttack(attackAction)) {
-                PerformAction(isLeft ? actionLeftRelease : actionRightAttack, playerCharacter, false);  
-            }
+        if (!IsActionDualAttack(attackAction)) {
+            PerformAction(isLeft ? actionLeftRelease : actionRightAttack, playerCharacter, false);  
         }
     }
 
     void TryIndicatePowerAttack(bool isLeft, PlayerCharacter* player) {
         float holdTime = isLeft ? leftHoldTime : rightHoldTime;
+        float triggerDepth = isLeft ? leftTriggerDepth : rightTriggerDepth;
 
         bool isBlocking = false;
         player->GetGraphVariableBool("IsBlocking", isBlocking);
 
         bool isPlayerAttacking = IsPlayerAttacking(player);
-        bool isPowerAttack = IsPowerAttackAlt(player, holdTime, leftAltBehavior, rightAltBehavior, isBlocking);
+        bool isHoldPowerAttack = IsHoldPowerAttack(holdTime, triggerDepth);
+        bool isPowerAttack = IsPowerAttackAlt(player, isHoldPowerAttack, leftAltBehavior, rightAltBehavior, isBlocking);
         
         if (!isPlayerAttacking && isPowerAttack) {
             if (isLeftAttackIndicated || isRightAttackIndicated) {
@@ -607,13 +715,22 @@ private:
 
         auto isLeft = IsEventLeft(buttonEvent);
 
+        if (isLeft && buttonEvent->IsDown()) {
+            dualAttackResolver.OnLeftDown();
+        }
+
         if (buttonEvent->IsDown() || buttonEvent->IsHeld()) {
+            // Up event may have been skipped while the event was invalid, so a new press starts a new depth
+            auto triggerDepth = GetTriggerDepth(buttonEvent);
+
             if (isLeft) {
                 leftHoldTime = buttonEvent->HeldDuration();
+                leftTriggerDepth = buttonEvent->IsDown() ? triggerDepth : Max(leftTriggerDepth, triggerDepth);
                 leftAltBehavior = false;
                 isRightDualHeld = isRightDualHeld || rightHoldTime > 0.0f;
             } else {
                 rightHoldTime = buttonEvent->HeldDuration();
+                rightTriggerDepth = buttonEvent->IsDown() ? triggerDepth : Max(rightTriggerDepth, triggerDepth);
                 rightAltBehavior = false;
                 isLeftDualHeld = isLeftDualHeld || leftHoldTime > 0.0f;
             }